@@ -1,5 +1,8 @@
 #include <iostream>
 #include <ctime>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #include "opencv2/core/core.hpp"
 #include "opencv2/highgui/highgui.hpp"
@@ -54,6 +57,94 @@ cv::Mat createImageFromRecognizerImage(const RecognizerImage* ri) {
 }
 
 
+/* Grabs frames from camera on a separate thread and keeps only the most recent one. This way camera capture runs at
+its own frame rate, while recognition processes frames as fast as CPU allows - frames that arrive while recognition of
+previous frame is still running are dropped instead of piling up in the camera queue. */
+class FrameGrabber {
+public:
+	explicit FrameGrabber(cv::VideoCapture& videoCapture) :
+		camera(videoCapture),
+		hasNewFrame(false),
+		running(true),
+		droppedFrames(0),
+		captureThread(&FrameGrabber::captureLoop, this) {}
+
+	~FrameGrabber() {
+		stop();
+	}
+
+	/* blocks until a frame newer than the previously obtained one is available. Returns false if grabber was stopped */
+	bool waitForFrame(cv::Mat& frame) {
+		std::unique_lock<std::mutex> lock(mutex);
+		frameAvailable.wait(lock, [this] { return hasNewFrame || !running; });
+		if (!hasNewFrame) {
+			return false;
+		}
+		frame = latestFrame;
+		hasNewFrame = false;
+		return true;
+	}
+
+	/* number of captured frames that were replaced by a newer frame before recognition could take them */
+	size_t getDroppedFramesCount() {
+		std::lock_guard<std::mutex> lock(mutex);
+		return droppedFrames;
+	}
+
+	/* stops capturing and waits for capture thread to finish. Must be called before camera is released */
+	void stop() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			running = false;
+		}
+		frameAvailable.notify_all();
+		if (captureThread.joinable()) {
+			captureThread.join();
+		}
+	}
+
+private:
+	void captureLoop() {
+		for (;;) {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (!running) {
+					return;
+				}
+			}
+
+			/* always capture into new cv::Mat, so that frame given to recognition is never overwritten */
+			cv::Mat frame;
+			camera >> frame;
+
+			if (frame.cols == 0 || frame.rows == 0) {
+				printf("Skipping empty frame\n");
+				continue;
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (hasNewFrame) {
+					++droppedFrames;
+				}
+				latestFrame = frame;
+				hasNewFrame = true;
+			}
+			frameAvailable.notify_one();
+		}
+	}
+
+	cv::VideoCapture& camera;
+	std::mutex mutex;
+	std::condition_variable frameAvailable;
+	cv::Mat latestFrame;
+	bool hasNewFrame;
+	bool running;
+	size_t droppedFrames;
+	/* must be declared last, so that thread is started after all other members are initialized */
+	std::thread captureThread;
+};
+
 void onDetectionStarted() {
 	printf("Detection has started!\n");
 }
@@ -166,8 +257,8 @@ int main(int argc, char** argv)
 	RecognizerCallback recognizerCallback;
 	/* this variable will contain list of scan results obtained from image scanning process. */
 	RecognizerResultList resultList;
-	/* this variable holds barreled image sent that will be debarreled */
-	RecognizerImage* image;
+	/* this variable holds barreled image sent that will be debarreled. It is created on first frame and reused for all following frames */
+	RecognizerImage* image = NULL;
 	/* barrelDewarper object used to debarrel images */
 	RecognizerBarrelDewarper *barrelDewarper;
 	/* this variable holds debarreled image that will be sent to scanning process */
@@ -230,6 +321,9 @@ int main(int argc, char** argv)
 	cv::namedWindow("Display debarreled window", cv::WINDOW_AUTOSIZE); // Create a window for display of debarreled frames.
 	cv::namedWindow("Text window", cv::WINDOW_AUTOSIZE); // Create a window for results.	
 
+	/* start capturing camera frames in background */
+	FrameGrabber frameGrabber(camera);
+
 	/* variable for storing user key presses */
     char keystroke = '\0';
 
@@ -240,16 +334,18 @@ int main(int argc, char** argv)
 		/* image for holding current video capture frame */
 		cv::Mat frame;
 
-		/* obtain current frame from camera */
-		camera >> frame;
-
-        if( frame.cols == 0 || frame.rows == 0 ) {
-            printf( "Skipping empty frame\n" );
-            continue;
-        }
+		/* obtain the most recent frame from camera, all older frames that were not processed are dropped */
+		if (!frameGrabber.waitForFrame(frame)) {
+			break;
+		}
 
-		/* create the recognizer image object from video capture frame so we can debarrel it*/
-		status = recognizerImageCreateFromRawImage(&image, frame.data, frame.cols, frame.rows, frame.step, frame.channels() == 3 ? RAW_IMAGE_TYPE_BGR : RAW_IMAGE_TYPE_BGRA);
+		/* create the recognizer image object from first video capture frame so we can debarrel it. For every following frame
+		just point the existing image to the new frame buffer - this is cheaper than deleting and creating the image for each frame */
+		if (image == NULL) {
+			status = recognizerImageCreateFromRawImage(&image, frame.data, frame.cols, frame.rows, frame.step, frame.channels() == 3 ? RAW_IMAGE_TYPE_BGR : RAW_IMAGE_TYPE_BGRA);
+		} else {
+			status = recognizerImageSetNewRawBuffer(image, frame.data, frame.cols, frame.rows, frame.step, frame.channels() == 3 ? RAW_IMAGE_TYPE_BGR : RAW_IMAGE_TYPE_BGRA);
+		}
 		if (status != RECOGNIZER_ERROR_STATUS_SUCCESS) {
 			std::cout << "Error creating image from frame: " << recognizerErrorToString(status) << std::endl;
 			return -1;
@@ -307,8 +403,6 @@ int main(int argc, char** argv)
 			cv::putText(console, "Press ESCAPE to exit demo", cv::Point(200, 250), cv::FONT_HERSHEY_COMPLEX_SMALL, 0.8, cv::Scalar(250, 250, 250), 1, CV_AA, false);
 		}
 
-		/* must delete recognizer image*/
-		recognizerImageDelete(&image);
 		/* free result list */
 		recognizerResultListDelete(&resultList);
 
@@ -337,10 +431,13 @@ int main(int argc, char** argv)
 	/* cleanup memory */	
 	recognizerSettingsDelete(&settings);
 	recognizerDelete(&recognizer);		
+	recognizerImageDelete(&image);
 	recognizerImageDelete(&debarreledImage);
 	recognizerBarrelDewarperDelete(&barrelDewarper);
 
-	/* release camera */
+	/* stop capturing and release camera */
+	frameGrabber.stop();
+	printf("Frames dropped while recognition was running: " JL_SIZE_T_SPECIFIER "\n", frameGrabber.getDroppedFramesCount());
 	camera.release();
 
 	return 0;
@@ -3,23 +3,53 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <jpeglib.h>
 
+/* libjpeg-turbo 1.5 and newer can skip scanlines and crop them horizontally while decoding */
+#if defined(LIBJPEG_TURBO_VERSION_NUMBER) && LIBJPEG_TURBO_VERSION_NUMBER >= 1005000
+#define JPEG_CROP_SUPPORTED
+#endif
+
+/* clamps relative coordinate to interval [0.f, 1.f] and converts it to pixels */
+static JDIMENSION relativeToPixels( float relative, JDIMENSION size ) {
+	if (relative < 0.f) relative = 0.f;
+	if (relative > 1.f) relative = 1.f;
+	return (JDIMENSION) (relative * size + 0.5f);
+}
+
+RecognizerImageWrapper loadImageFromFile( const char* filePath ) {
+	return loadImageFromFileScaled( filePath, 1, 0 );
+}
+
+RecognizerImageWrapper loadImageFromFileScaled( const char* filePath, unsigned int scaleDenom, int grayscale ) {
+	return loadImageRegionFromFile( filePath, NULL, scaleDenom, grayscale );
+}
+
 /* read the image using libjpeg */
 /* code based on example from Github: https://github.com/ellzey/libjpeg/blob/master/example.c ) */
-RecognizerImageWrapper loadImageFromFile( const char* filePath ) {
+RecognizerImageWrapper loadImageRegionFromFile( const char* filePath, const MBRectangle* roi, unsigned int scaleDenom, int grayscale ) {
 	struct jpeg_decompress_struct cinfo;
 	struct jpeg_error_mgr jerr;
 	/* source image file */
 	FILE * infile;
-	JSAMPARRAY buffer;	/* Output row buffer */
-	int row_stride;		/* physical row width in output buffer */
-	unsigned char r,g,b;
-	unsigned char* dummy;
+	JSAMPROW row;		/* pointer to the output row inside imageBuffer */
+	size_t row_stride;	/* physical row width in output buffer */
+	JDIMENSION x0, y0, width, height; /* decoded region, in pixels of the scaled image */
+	JDIMENSION full_width, full_height; /* size of the whole scaled image */
+	JDIMENSION y;		/* for loop counter (this example is C89-compatible) */
+	RawImageType raw_type;
 	RecognizerImageWrapper result;
+#ifndef JPEG_CROP_SUPPORTED
+	JSAMPROW full_row = NULL; /* full width scanline, used only if region must be cut out after decoding */
+#endif
 
 	result.recognizerImage = NULL;
 	result.imageBuffer	   = NULL;
+	result.region.x		   = 0.f;
+	result.region.y		   = 0.f;
+	result.region.width	   = 0.f;
+	result.region.height   = 0.f;
 
 	if ((infile = fopen(filePath, "rb")) == NULL) {
 		fprintf(stderr, "can't open %s\n", filePath);
@@ -30,41 +60,118 @@ RecognizerImageWrapper loadImageFromFile( const char* filePath ) {
 	jpeg_create_decompress(&cinfo);
 	jpeg_stdio_src(&cinfo, infile);
 	(void) jpeg_read_header(&cinfo, TRUE);
+
+	/* let libjpeg downscale the image while decoding - this skips most of the IDCT work instead of
+	   decoding the full resolution image and scaling it down afterwards */
+	cinfo.scale_num   = 1;
+	cinfo.scale_denom = scaleDenom > 0 ? scaleDenom : 1;
+
+	/* RecognizerAPI accepts GRAY, BGR and BGRA images. Grayscale JPEGs are given to it as they are, and colour
+	   JPEGs are decoded directly to BGR if libjpeg supports it (libjpeg-turbo does), so no extra pass over
+	   the pixels is required. If caller does not need colour, only the luminance is decoded */
+	if (grayscale || cinfo.jpeg_color_space == JCS_GRAYSCALE) {
+		cinfo.out_color_space = JCS_GRAYSCALE;
+		raw_type = RAW_IMAGE_TYPE_GRAY;
+	} else {
+#ifdef JCS_EXTENSIONS
+		cinfo.out_color_space = JCS_EXT_BGR;
+#else
+		cinfo.out_color_space = JCS_RGB;
+#endif
+		raw_type = RAW_IMAGE_TYPE_BGR;
+	}
+
 	(void) jpeg_start_decompress(&cinfo);
-	
-	result.imageBuffer = ( unsigned char* )malloc( cinfo.output_width * cinfo.output_height * 3 );
-	dummy = result.imageBuffer;
-
-	row_stride = cinfo.output_width * cinfo.output_components;
-	buffer = (*cinfo.mem->alloc_sarray)
-		((j_common_ptr) &cinfo, JPOOL_IMAGE, row_stride, 1);
-
-	while (cinfo.output_scanline < cinfo.output_height) {
-		int x; /* for loop counter (this example is C89-compatible) */
-
-		(void) jpeg_read_scanlines(&cinfo, buffer, 1);
-
-		/* RecognizerAPI accepts BGR and BGRA images, and libjpeg returns RGB order, so we need to revert the pixel order */
-
-	    for (x = 0; x < cinfo.output_width; x++) {
-	     	r = buffer[0][cinfo.output_components * x];
-	      	if (cinfo.output_components > 2) {
-	        	g = buffer[0][cinfo.output_components * x + 1];
-	        	b = buffer[0][cinfo.output_components * x + 2];
-	      	} else {
-	        	g = r;
-	        	b = r;
-	      	}
-	      *(dummy++) = b;
-	      *(dummy++) = g;
-	      *(dummy++) = r;
-	    }
+
+	/* ROI is given in relative coordinates, same as for recognizerSetROI */
+	full_width  = cinfo.output_width;
+	full_height = cinfo.output_height;
+	x0     = 0;
+	y0     = 0;
+	width  = full_width;
+	height = full_height;
+	if (roi != NULL) {
+		JDIMENSION x1 = relativeToPixels( roi->x + roi->width, full_width );
+		JDIMENSION y1 = relativeToPixels( roi->y + roi->height, full_height );
+
+		x0 = relativeToPixels( roi->x, full_width );
+		y0 = relativeToPixels( roi->y, full_height );
+		width  = x1 > x0 ? x1 - x0 : 0;
+		height = y1 > y0 ? y1 - y0 : 0;
+
+		if (width == 0 || height == 0) {
+			fprintf(stderr, "ROI does not contain any pixels of %s\n", filePath);
+			jpeg_destroy_decompress(&cinfo);
+			fclose(infile);
+			return result;
+		}
+
+#ifdef JPEG_CROP_SUPPORTED
+		/* decode only the iMCU columns intersecting the ROI and skip all rows above it. libjpeg moves
+		   the left edge left to the iMCU boundary and updates x0 and width accordingly, so the decoded
+		   region may be slightly wider than requested */
+		jpeg_crop_scanline(&cinfo, &x0, &width);
+		(void) jpeg_skip_scanlines(&cinfo, y0);
+#else
+		full_row = (JSAMPROW) malloc( (size_t) full_width * cinfo.output_components );
+		while (cinfo.output_scanline < y0) {
+			(void) jpeg_read_scanlines(&cinfo, &full_row, 1);
+		}
+#endif
+	}
+
+	row_stride = (size_t) width * cinfo.output_components;
+	result.imageBuffer = ( unsigned char* )malloc( row_stride * height );
+
+	/* decode scanlines directly into the image buffer */
+	for (y = 0; y < height; ++y) {
+		row = result.imageBuffer + y * row_stride;
+
+#ifdef JPEG_CROP_SUPPORTED
+		(void) jpeg_read_scanlines(&cinfo, &row, 1);
+#else
+		if (full_row != NULL) {
+			(void) jpeg_read_scanlines(&cinfo, &full_row, 1);
+			memcpy(row, full_row + (size_t) x0 * cinfo.output_components, row_stride);
+		} else {
+			(void) jpeg_read_scanlines(&cinfo, &row, 1);
+		}
+#endif
+
+#ifndef JCS_EXTENSIONS
+		/* libjpeg returns RGB order, so we need to revert the pixel order */
+		if (raw_type == RAW_IMAGE_TYPE_BGR) {
+			JDIMENSION x;
+			unsigned char r;
+
+			for (x = 0; x < width; x++) {
+				r = row[3 * x];
+				row[3 * x] = row[3 * x + 2];
+				row[3 * x + 2] = r;
+			}
+		}
+#endif
 	}
 
-	(void) jpeg_finish_decompress(&cinfo);
+	/* rows below the ROI are never decoded */
+	if (cinfo.output_scanline < cinfo.output_height) {
+		jpeg_abort_decompress(&cinfo);
+	} else {
+		(void) jpeg_finish_decompress(&cinfo);
+	}
+
+#ifndef JPEG_CROP_SUPPORTED
+	free( full_row );
+#endif
+
+	/* report the part of the image that was actually decoded */
+	result.region.x		 = (float) x0 / full_width;
+	result.region.y		 = (float) y0 / full_height;
+	result.region.width	 = (float) width / full_width;
+	result.region.height = (float) height / full_height;
 
 	/* now create RecognizerImage */
-	recognizerImageCreateFromRawImage( &result.recognizerImage, result.imageBuffer, cinfo.output_width, cinfo.output_height, row_stride, RAW_IMAGE_TYPE_BGR );
+	recognizerImageCreateFromRawImage( &result.recognizerImage, result.imageBuffer, width, height, row_stride, raw_type );
 
 	jpeg_destroy_decompress(&cinfo);
 	fclose(infile);
@@ -75,7 +182,7 @@ RecognizerImageWrapper loadImageFromFile( const char* filePath ) {
 void terminateImageWrapper( RecognizerImageWrapper * image ) {
 	recognizerImageDelete( &image->recognizerImage );
 	free( image->imageBuffer );
-	
+
 	image->recognizerImage = NULL;
 	image->imageBuffer	   = NULL;
-}
\ No newline at end of file
+}
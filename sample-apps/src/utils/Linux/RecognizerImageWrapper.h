@@ -9,6 +9,8 @@
 struct RecognizerImageWrapper {
     RecognizerImage* recognizerImage;
     unsigned char*   imageBuffer;
+    /** part of the original image contained in recognizerImage, in relative coordinates (whole image is 0, 0, 1, 1) */
+    MBRectangle      region;
 };
 
 typedef struct RecognizerImageWrapper RecognizerImageWrapper;
@@ -16,4 +18,25 @@ typedef struct RecognizerImageWrapper RecognizerImageWrapper;
 RecognizerImageWrapper loadImageFromFile    ( const char             * filePath );
 void                   terminateImageWrapper( RecognizerImageWrapper * image    );
 
+/**
+ Loads image downscaled while decoding. libjpeg (v7 and newer, and libjpeg-turbo) can only scale by
+ M/8, so the image is scaled by the smallest M/8 that is not below 1 / scaleDenom, and never below 1/8:
+ 1, 2, 4 and 8 give exactly 1/1, 1/2, 1/4 and 1/8, while e.g. 3 gives 3/8 and 5 gives 2/8. libjpeg 6b
+ supports only 1/1, 1/2, 1/4 and 1/8. Use recognizerImageGetWidth and recognizerImageGetHeight to obtain
+ the actual size. If grayscale is non-zero, only the luminance channel is decoded and the image is created
+ as RAW_IMAGE_TYPE_GRAY.
+ */
+RecognizerImageWrapper loadImageFromFileScaled( const char * filePath, unsigned int scaleDenom, int grayscale );
+
+/**
+ Same as loadImageFromFileScaled, but decodes only the part of the image covered by roi, given in relative
+ coordinates like for recognizerSetROI. With libjpeg-turbo, columns and rows outside of roi are not decoded
+ at all, and the left edge is moved left to the JPEG block (iMCU) boundary, making the image wider by the
+ same amount. The part that was actually decoded is returned in the region field, which should be used to
+ map points from the returned image back to the original image:
+    originalX = ( region.x + x / imageWidth * region.width ) * originalWidth
+ The returned image contains only the region, so do not set the same ROI to the Recognizer.
+ */
+RecognizerImageWrapper loadImageRegionFromFile( const char * filePath, const MBRectangle * roi, unsigned int scaleDenom, int grayscale );
+
 #endif
\ No newline at end of file